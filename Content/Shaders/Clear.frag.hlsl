@@ -0,0 +1,8 @@
+cbuffer UniformBlock : register(b0, space3)
+{
+    float4 ClearColor : packoffset(c0);
+};
+
+float4 Main(): SV_Target0 {
+    return ClearColor;
+}
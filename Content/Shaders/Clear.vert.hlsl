@@ -0,0 +1,17 @@
+// Single triangle covering the whole viewport, placed on the far plane so it resets depth as well
+static const float2 vertexPositions[3] = {
+    {-1.0f, -1.0f},
+    {3.0f, -1.0f},
+    {-1.0f, 3.0f}
+};
+
+struct VSOutput {
+    float4 Position: SV_Position;
+};
+
+VSOutput Main(uint id: SV_VertexID) {
+    VSOutput output;
+    output.Position = float4(vertexPositions[id], 1.0f, 1.0f);
+
+    return output;
+}
@@ -33,15 +33,18 @@ struct VSOutput {
 };
 
 StructuredBuffer<SpriteData> DataBuffer : register(t0, space0);
+// Culled sprite indices for every view, each view draws from FirstIndex onwards
+StructuredBuffer<uint> IndexBuffer : register(t1, space0);
 
 cbuffer UniformBlock : register(b0, space1)
 {
     float4x4 ViewProjectionMatrix : packoffset(c0);
+    uint FirstIndex : packoffset(c4);
 };
 
 VSOutput Main(uint id: SV_VertexID) {
 
-    uint spriteIndex = id / 6;
+    uint spriteIndex = IndexBuffer[FirstIndex + id / 6];
     SpriteData sprite = DataBuffer[spriteIndex];
 
     uint vertexIndex = triangleIndices[id % 6];
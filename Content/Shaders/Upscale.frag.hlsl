@@ -0,0 +1,20 @@
+Texture2D<float4> Texture: register(t0, space2);
+SamplerState Sampler: register(s0, space2);
+
+cbuffer UniformBlock : register(b0, space3)
+{
+    // Maps 0..1 onto the rendered region of the scene target
+    float2 UVScale : packoffset(c0.x);
+    // Half a texel inside the rendered region, so bilinear filtering never reaches the cleared texels around it
+    float2 UVMin : packoffset(c0.z);
+    float2 UVMax : packoffset(c1.x);
+};
+
+struct PSInput {
+    float2 UV: TEXCOORD0;
+};
+
+float4 Main(const PSInput input): SV_Target0 {
+    float2 uv = clamp(input.UV * UVScale, UVMin, UVMax);
+    return Texture.Sample(Sampler, uv);
+}
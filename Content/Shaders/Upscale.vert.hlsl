@@ -0,0 +1,25 @@
+// Single triangle covering the whole target, UVs run 0..1 over the visible part
+static const float2 vertexPositions[3] = {
+    {-1.0f, -1.0f},
+    {3.0f, -1.0f},
+    {-1.0f, 3.0f}
+};
+
+static const float2 uvCoordinates[3] = {
+    {0.0f, 1.0f},
+    {2.0f, 1.0f},
+    {0.0f, -1.0f}
+};
+
+struct VSOutput {
+    float2 UV: TEXCOORD0;
+    float4 Position: SV_Position;
+};
+
+VSOutput Main(uint id: SV_VertexID) {
+    VSOutput output;
+    output.Position = float4(vertexPositions[id], 0.0f, 1.0f);
+    output.UV = uvCoordinates[id];
+
+    return output;
+}
@@ -0,0 +1,104 @@
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include "glm/ext/matrix_clip_space.hpp"
+#include "glm/ext/matrix_float4x4.hpp"
+#include "glm/ext/vector_float3.hpp"
+#include "glm/trigonometric.hpp"
+#include "spatial.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    static const float SpriteRadius = 45.25f;
+    static const float CellSize = 256.0f;
+    // Note: Average area per object, keeps the number of visible objects constant as the world grows
+    static const float AreaPerObject = 64.0f * 64.0f;
+    static const float MoverSpeed = 8.0f;
+
+    double MillisecondsSince(const Clock::time_point &start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    void RunBenchmark(const std::size_t objectCount, const float moverFraction, const int frames) {
+        std::mt19937 random(1234);
+        const float extent = std::sqrt(objectCount * AreaPerObject) * 0.5f;
+        std::uniform_real_distribution<float> worldDistribution(-extent, extent);
+        std::uniform_real_distribution<float> depthDistribution(25.0f, 800.0f);
+        std::uniform_real_distribution<float> stepDistribution(-MoverSpeed, MoverSpeed);
+
+        spatial::SpatialGrid grid(CellSize);
+        std::vector<glm::vec3> positions(objectCount);
+
+        auto start = Clock::now();
+        for (std::size_t i = 0; i < objectCount; i++) {
+            positions[i] = glm::vec3(worldDistribution(random), worldDistribution(random), depthDistribution(random));
+            grid.Insert(positions[i], SpriteRadius);
+        }
+        const double buildTime = MillisecondsSince(start);
+
+        const std::size_t moverCount = std::min(static_cast<std::size_t>(objectCount * moverFraction), objectCount);
+        const glm::mat4 projection = glm::perspectiveFovLH<float>(glm::radians(90.0f), 800.0f, 600.0f, 0.01f, 1000.0f);
+        const spatial::Frustum frustum = spatial::Frustum::FromViewProjection(projection);
+
+        std::vector<spatial::ObjectHandle> visible;
+        double updateTime = 0.0;
+        double queryTime = 0.0;
+        double linearTime = 0.0;
+        std::size_t linearVisible = 0;
+
+        for (int frame = 0; frame < frames; frame++) {
+            start = Clock::now();
+            for (std::size_t i = 0; i < moverCount; i++) {
+                positions[i].x += stepDistribution(random);
+                positions[i].y += stepDistribution(random);
+                grid.Move(static_cast<spatial::ObjectHandle>(i), positions[i]);
+            }
+            updateTime += MillisecondsSince(start);
+
+            start = Clock::now();
+            visible.clear();
+            grid.QueryFrustum(frustum, visible);
+            queryTime += MillisecondsSince(start);
+
+            start = Clock::now();
+            linearVisible = 0;
+            for (const glm::vec3 &position : positions) {
+                if (frustum.ContainsSphere(position, SpriteRadius)) {
+                    linearVisible++;
+                }
+            }
+            linearTime += MillisecondsSince(start);
+        }
+
+        std::cout << objectCount << " objects, " << moverCount << " movers: "
+                  << "build " << buildTime << " ms, "
+                  << "update " << updateTime / frames << " ms, "
+                  << "query " << queryTime / frames << " ms (" << visible.size() << " visible), "
+                  << "linear scan " << linearTime / frames << " ms (" << linearVisible << " visible)"
+                  << std::endl;
+    }
+}
+
+/**
+ * Usage: spatial_bench [mover fraction] [frames]
+ */
+int main(int argc, char **argv) {
+    const float moverFraction = std::clamp(argc > 1 ? std::strtof(argv[1], nullptr) : 0.1f, 0.0f, 1.0f);
+    const int frames = argc > 2 ? std::atoi(argv[2]) : 30;
+    if (frames < 1) {
+        std::cerr << "frames must be at least 1" << std::endl;
+        return 1;
+    }
+
+    for (const std::size_t objectCount : {100000, 1000000, 10000000}) {
+        RunBenchmark(objectCount, moverFraction, frames);
+    }
+
+    return 0;
+}
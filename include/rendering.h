@@ -2,7 +2,10 @@
 
 #include "transform.h"
 #include "camera.h"
+#include "glm/ext/matrix_float4x4.hpp"
+#include "resolution.h"
 #include <string>
+#include <vector>
 
 namespace rendering {
     typedef int TextureHandle;
@@ -15,6 +18,27 @@ namespace rendering {
         float scale_y;
     };
 
+    /**
+     * Region of the window a view draws to, normalized from the top left.
+     */
+    struct Viewport {
+        float x = 0.0f;
+        float y = 0.0f;
+        float width = 1.0f;
+        float height = 1.0f;
+    };
+
+    struct View {
+        Viewport viewport;
+        // Vertical field of view in degrees
+        float fov = 90.0f;
+        float near_plane = 0.01f;
+        float far_plane = 1000.0f;
+        // Whether the view draws its own background where it overlaps earlier views, otherwise they show through
+        bool clear_background = true;
+        camera::Camera camera;
+    };
+
     /**
      * Initializes the game window and renderer state.
      */
@@ -31,6 +55,40 @@ namespace rendering {
 
     void DrawSprite(const Sprite &sprite, const transform::Transform &transform);
 
+    /**
+     * Radius of a sphere enclosing the sprite's quad, used for culling.
+     */
+    float BoundingRadius(const Sprite &sprite);
+
     void DrawFrame(const camera::Camera &camera);
 
+    /**
+     * Draws the queued sprites once per view, in order. Sprite data is uploaded once and shared by every view.
+     *
+     * Views with an empty viewport or an invalid projection are dropped.
+     */
+    void DrawFrame(const std::vector<View> &views);
+
+    /**
+     * Sets the frame time in milliseconds the dynamic resolution scaling tries to hold.
+     */
+    void SetTargetFrameTime(const float milliseconds);
+
+    /**
+     * Replaces every dynamic resolution scaling setting, including the min and max scale.
+     */
+    void SetResolutionScaling(const resolution::ScalerSettings &settings);
+
+    /**
+     * Fraction of the window resolution the scene is currently rendered at.
+     */
+    float GetResolutionScale();
+
+    /**
+     * Combined view and projection matrix used to draw the frame for the given camera.
+     */
+    glm::mat4 ViewProjection(const camera::Camera &camera);
+
+    glm::mat4 ViewProjection(const View &view);
+
 }
@@ -0,0 +1,54 @@
+#pragma once
+
+namespace resolution {
+    struct ScalerSettings {
+        float target_frame_time = 1000.0f / 60.0f;
+        float min_scale = 0.5f;
+        float max_scale = 1.0f;
+        // Note: Fractions of the target frame time, the gap between them is the hysteresis band
+        float decrease_threshold = 1.0f;
+        float increase_threshold = 0.85f;
+        float increase_step = 0.05f;
+        // Frames to wait after a change before the next one, lets the smoothed timings settle
+        int cooldown_frames = 15;
+        float smoothing = 0.1f;
+    };
+
+    struct FrameTimings {
+        float cpu_time;
+        // Note: Only meaningful when gpu_bound, the gpu's pace can't be measured while it keeps up
+        float gpu_time;
+        // Whether the cpu had to wait on the gpu this frame
+        bool gpu_bound;
+    };
+
+    /**
+     * Picks a render scale from measured frame timings to hold a target frame time.
+     */
+    class DynamicScaler {
+        public:
+            DynamicScaler();
+            explicit DynamicScaler(const ScalerSettings &settings);
+
+            /**
+             * Feeds the timings of the last frame in milliseconds and returns the scale to render the next one at.
+             */
+            float Update(const FrameTimings &timings);
+
+            float Scale() const;
+            void SetTargetFrameTime(const float milliseconds);
+
+            /**
+             * Replaces the settings, keeping the current scale within the new limits.
+             */
+            void SetSettings(const ScalerSettings &settings);
+        private:
+            ScalerSettings settings;
+            float scale;
+            float smoothedCpuTime;
+            float smoothedGpuTime;
+            // Fraction of recent frames where the cpu waited on the gpu
+            float smoothedGpuBound;
+            int cooldown;
+    };
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "glm/ext/matrix_float4x4.hpp"
+#include "glm/ext/vector_float2.hpp"
+#include "glm/ext/vector_float3.hpp"
+#include "glm/ext/vector_float4.hpp"
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+namespace spatial {
+    typedef std::uint32_t ObjectHandle;
+
+    constexpr ObjectHandle InvalidObject = std::numeric_limits<ObjectHandle>::max();
+
+    /**
+     * View frustum planes, stored as (normal, distance) with normals pointing inwards.
+     */
+    struct Frustum {
+        enum Plane {
+            Left,
+            Right,
+            Bottom,
+            Top,
+            Near,
+            Far,
+            PlaneCount,
+        };
+
+        glm::vec4 planes[PlaneCount];
+        glm::vec3 corners[8];
+
+        /**
+         * Extracts the frustum from a view projection matrix with a zero to one depth range.
+         */
+        static Frustum FromViewProjection(const glm::mat4 &viewProjection);
+
+        bool ContainsSphere(const glm::vec3 &center, const float radius) const;
+        bool IntersectsBox(const glm::vec3 &min, const glm::vec3 &max) const;
+    };
+
+    /**
+     * Loose uniform grid over the XY plane keyed on transform position.
+     *
+     * Objects are bucketed by their center only, queries are widened by the largest radius
+     * seen so an object is never split across cells. Moving within a cell only rewrites the
+     * stored position.
+     */
+    class SpatialGrid {
+        public:
+            explicit SpatialGrid(const float cellSize);
+
+            ObjectHandle Insert(const glm::vec3 &position, const float radius);
+            void Move(const ObjectHandle handle, const glm::vec3 &position);
+            void Remove(const ObjectHandle handle);
+
+            const glm::vec3 &GetPosition(const ObjectHandle handle) const;
+            std::size_t Size() const;
+
+            /**
+             * Appends every object overlapping the XY rectangle to results.
+             */
+            void QueryRect(const glm::vec2 &min, const glm::vec2 &max, std::vector<ObjectHandle> &results) const;
+
+            /**
+             * Appends every object whose bounding sphere intersects the frustum to results.
+             */
+            void QueryFrustum(const Frustum &frustum, std::vector<ObjectHandle> &results) const;
+
+        private:
+            typedef std::uint64_t CellKey;
+
+            struct Object {
+                glm::vec3 position;
+                float radius;
+                CellKey cell;
+                // Note: Index into the owning cell's handle list, InvalidObject when the slot is free
+                std::uint32_t slot;
+            };
+
+            struct Cell {
+                std::vector<ObjectHandle> handles;
+            };
+
+            std::int32_t CellCoordinate(const float value) const;
+            CellKey KeyFor(const std::int32_t x, const std::int32_t y) const;
+            CellKey KeyFor(const glm::vec3 &position) const;
+            void AddToCell(const ObjectHandle handle, const CellKey key);
+            void RemoveFromCell(const ObjectHandle handle);
+
+            /**
+             * Calls visit(x, y, cell) for every occupied cell in the inclusive range.
+             *
+             * Note: Walks the map instead when the range covers more cells than are occupied, so a query never costs
+             * more than the smaller of its footprint and the occupied world.
+             */
+            template <typename Visit>
+            void VisitCells(const std::int32_t startX, const std::int32_t startY, const std::int32_t endX, const std::int32_t endY, Visit visit) const {
+                if (startX > endX || startY > endY) {
+                    return;
+                }
+
+                const double footprint = (static_cast<double>(endX) - startX + 1.0) * (static_cast<double>(endY) - startY + 1.0);
+                if (footprint > static_cast<double>(this->cells.size())) {
+                    for (const auto &[key, cell] : this->cells) {
+                        const std::int32_t x = static_cast<std::int32_t>(key >> 32);
+                        const std::int32_t y = static_cast<std::int32_t>(key & 0xFFFFFFFF);
+                        if (x >= startX && x <= endX && y >= startY && y <= endY) {
+                            visit(x, y, cell);
+                        }
+                    }
+                    return;
+                }
+
+                for (std::int32_t y = startY; y <= endY; y++) {
+                    for (std::int32_t x = startX; x <= endX; x++) {
+                        const auto found = this->cells.find(KeyFor(x, y));
+                        if (found != this->cells.end()) {
+                            visit(x, y, found->second);
+                        }
+                    }
+                }
+            }
+
+            float cellSize;
+            float inverseCellSize;
+            float maxRadius;
+            float minZ, maxZ;
+
+            std::vector<Object> objects;
+            std::vector<ObjectHandle> freeHandles;
+            std::unordered_map<CellKey, Cell> cells;
+    };
+}
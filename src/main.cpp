@@ -7,7 +7,9 @@
 #include "rendering.h"
 #include "transform.h"
 #include "camera.h"
+#include "spatial.h"
 #include <iostream>
+#include <vector>
 
 int main() {
 
@@ -23,6 +25,30 @@ int main() {
 
     camera::Camera camera;
 
+    static const int WorldSpriteCount = 100000;
+    static const float WorldExtent = 20000.0f;
+    const float spriteRadius = rendering::BoundingRadius(sprite);
+
+    spatial::SpatialGrid world(256.0f);
+    std::vector<transform::Transform> worldTransforms;
+    worldTransforms.reserve(WorldSpriteCount);
+
+    for (int i = 0; i < WorldSpriteCount; i++) {
+        transform::Transform transform = {
+            .position = glm::vec3(
+                (SDL_randf() * 2.0f - 1.0f) * WorldExtent,
+                (SDL_randf() * 2.0f - 1.0f) * WorldExtent,
+                25.0f + SDL_randf() * 750.0f
+            ),
+            .rotation = glm::quat_cast(glm::identity<glm::mat4>()),
+        };
+        // Handles are handed out sequentially, so they double as indices into worldTransforms
+        world.Insert(transform.position, spriteRadius);
+        worldTransforms.push_back(transform);
+    }
+
+    std::vector<spatial::ObjectHandle> visible;
+
     int frameCount = 0;
 
     uint startTime = SDL_GetTicks();
@@ -40,20 +66,11 @@ int main() {
         // camera.Move(-0.01f, 0.0f);
 
         rendering::BeginFrame();
-        float distance = 25.0f;
-
-        for (int i = 0; i < 10; i++) {
-            transform::Transform transform = {
-                .position = glm::vec3(
-                    i * 100.f,
-                    0.0f,
-                    distance
-                ),
-
-                .rotation = glm::quat_cast(glm::identity<glm::mat4>()),
-            };
-            rendering::DrawSprite(sprite, transform);
-            distance += 75.0f;
+
+        visible.clear();
+        world.QueryFrustum(spatial::Frustum::FromViewProjection(rendering::ViewProjection(camera)), visible);
+        for (const spatial::ObjectHandle handle : visible) {
+            rendering::DrawSprite(sprite, worldTransforms[handle]);
         }
 
         rendering::DrawFrame(camera);
@@ -2,6 +2,7 @@
 #include "SDL3/SDL_gpu.h"
 #include "SDL3/SDL_init.h"
 #include "SDL3/SDL_log.h"
+#include "SDL3/SDL_timer.h"
 #include "SDL3/SDL_video.h"
 #include "SDL3_image/SDL_image.h"
 #include "SDL3_shadercross/SDL_shadercross.h"
@@ -11,7 +12,10 @@
 #include "glm/fwd.hpp"
 #include "glm/gtc/quaternion.hpp"
 #include "glm/trigonometric.hpp"
+#include "resolution.h"
+#include "spatial.h"
 #include "transform.h"
+#include <cmath>
 #include <iostream>
 #include <sys/types.h>
 #include <vector>
@@ -27,6 +31,8 @@ namespace rendering {
 
         namespace sprite {
             static const uint MaxSpriteCount = 1024;
+            static const uint MaxViewCount = 4;
+            static const uint MaxIndexCount = MaxSpriteCount * MaxViewCount;
 
             struct Instance {
                 glm::mat4 transform;
@@ -37,24 +43,51 @@ namespace rendering {
                 float r, g, b, a;
             };
 
+            // Note: Instances are packed once per frame, each view then draws through its own slice of the index buffer
+            struct ViewDraw {
+                glm::mat4 viewProjection;
+                Uint32 firstIndex;
+                Uint32 indexCount;
+            };
+
+            // Note: Layout must match UniformBlock in Sprite.vert.hlsl
+            struct ViewUniforms {
+                glm::mat4 viewProjection;
+                Uint32 firstIndex;
+                Uint32 _padding[3];
+            };
+
             // Note: Data is considered valid only for the current frame and up to drawCount
             QueuedDraw<Sprite> drawQueue[MaxSpriteCount];
             Uint32 drawCount;
+            // Note: Holds the instance data followed by the index data so the frame only maps once
             SDL_GPUTransferBuffer *dataTransferBuffer;
             SDL_GPUBuffer *dataBuffer;
+            SDL_GPUBuffer *indexBuffer;
         };
 
         struct GraphicsPipelines {
             SDL_GPUGraphicsPipeline* sprite;
+            SDL_GPUGraphicsPipeline* upscale;
+            SDL_GPUGraphicsPipeline* clear_color_depth;
+            SDL_GPUGraphicsPipeline* clear_depth;
         };
 
         struct Samplers {
             SDL_GPUSampler *nearest_clamped;
+            SDL_GPUSampler *linear_clamped;
+        };
+
+        // Note: Layout must match UniformBlock in Upscale.frag.hlsl
+        struct UpscaleUniforms {
+            float uv_scale[2];
+            float uv_min[2];
+            float uv_max[2];
+            float _padding[2];
         };
 
         static const uint WindowWidth = 800;
         static const uint WindowHeight = 600;
-        static const uint Fov = 90;
 
 
         constexpr SDL_FColor CLEAR_COLOR{
@@ -65,16 +98,39 @@ namespace rendering {
         };
 
 
+        struct RenderTargets {
+            SDL_GPUTexture *color;
+            SDL_GPUTexture *depth;
+            SDL_GPUTextureFormat colorFormat;
+            // Note: Size of the swapchain, the scene is only rendered into the top left region scaled by the resolution scale
+            Uint32 width, height;
+        };
+
+        // Note: Also handed to SDL_SetGPUAllowedFramesInFlight so the fence ring is where the cpu blocks, not swapchain acquisition
+        static const Uint32 MaxFramesInFlight = 3;
+        // Acquiring the swapchain for longer than this means presentation is throttling us, e.g. when stuck on vsync
+        static const float AcquireWaitThreshold = 0.25f;
+
+        struct FrameTiming {
+            Uint64 frameStart;
+            float cpuTime;
+            // Note: Ring of fences for submitted frames, oldest at fenceHead
+            SDL_GPUFence *fences[MaxFramesInFlight];
+            Uint32 fenceHead;
+            Uint32 fenceCount;
+            // Note: When the last waited on frame finished, zero once a frame finishes without being waited on
+            Uint64 lastCompletion;
+        };
+
         SDL_GPUDevice *device;
         SDL_Window *window;
-        SDL_GPUTexture *depthTexture;
+        RenderTargets renderTargets;
+        FrameTiming frameTiming;
+        resolution::DynamicScaler resolutionScaler;
         Samplers samplers;
         GraphicsPipelines pipelines;
 
 
-        glm::mat4 projectionMatrix;
-
-
         // Note: Append only to keep handles consistent for the lifetime of the game
         std::vector<SDL_GPUTexture *> textures;
     }
@@ -194,6 +250,71 @@ namespace rendering {
         return pipeline;
     }
 
+    SDL_GPUGraphicsPipeline* LoadUpscalePipeline(SDL_GPUDevice* device, SDL_GPUTextureFormat textureFormat) {
+        SDL_GPUColorTargetDescription colorTargetDescription = {
+            .format = textureFormat,
+        };
+
+        SDL_GPUGraphicsPipelineCreateInfo pipelineCreateInfo = {
+            .vertex_shader = LoadAndCompileShader(device, "Upscale.vert"),
+            .fragment_shader = LoadAndCompileShader(device, "Upscale.frag"),
+            .primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
+            .target_info = {
+                    .color_target_descriptions = &colorTargetDescription,
+                    .num_color_targets = 1,
+                    .has_depth_stencil_target = false,
+            },
+        };
+
+        SDL_GPUGraphicsPipeline* pipeline = SDL_CreateGPUGraphicsPipeline(device, &pipelineCreateInfo);
+
+        SDL_ReleaseGPUShader(device, pipelineCreateInfo.vertex_shader);
+        SDL_ReleaseGPUShader(device, pipelineCreateInfo.fragment_shader);
+
+        return pipeline;
+    }
+
+    /**
+     * Pipeline that resets the current viewport's depth, and its color when writeColor is set, by drawing on the far plane.
+     */
+    SDL_GPUGraphicsPipeline* LoadClearPipeline(SDL_GPUDevice* device, SDL_GPUTextureFormat textureFormat, const bool writeColor) {
+        SDL_GPUColorTargetDescription colorTargetDescription = {
+            .format = textureFormat,
+            .blend_state = {
+                .color_write_mask = 0,
+                .enable_color_write_mask = !writeColor,
+            }
+        };
+
+        SDL_GPUDepthStencilState depthStencilState = {
+            .compare_op = SDL_GPU_COMPAREOP_ALWAYS,
+            .write_mask = 0xFF,
+            .enable_depth_test = true,
+            .enable_depth_write = true,
+            .enable_stencil_test = false,
+        };
+
+        SDL_GPUGraphicsPipelineCreateInfo pipelineCreateInfo = {
+            .vertex_shader = LoadAndCompileShader(device, "Clear.vert"),
+            .fragment_shader = LoadAndCompileShader(device, "Clear.frag"),
+            .primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
+            .depth_stencil_state = depthStencilState,
+            .target_info = {
+                    .color_target_descriptions = &colorTargetDescription,
+                    .num_color_targets = 1,
+                    .depth_stencil_format = SDL_GPU_TEXTUREFORMAT_D16_UNORM,
+                    .has_depth_stencil_target = true,
+            },
+        };
+
+        SDL_GPUGraphicsPipeline* pipeline = SDL_CreateGPUGraphicsPipeline(device, &pipelineCreateInfo);
+
+        SDL_ReleaseGPUShader(device, pipelineCreateInfo.vertex_shader);
+        SDL_ReleaseGPUShader(device, pipelineCreateInfo.fragment_shader);
+
+        return pipeline;
+    }
+
     Samplers InitSamplers() {
         SDL_GPUSamplerCreateInfo nearestClampedSamplerCreateInfo = {
             .min_filter = SDL_GPU_FILTER_NEAREST,
@@ -203,11 +324,75 @@ namespace rendering {
             .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
             .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
         };
+        SDL_GPUSamplerCreateInfo linearClampedSamplerCreateInfo = {
+            .min_filter = SDL_GPU_FILTER_LINEAR,
+            .mag_filter = SDL_GPU_FILTER_LINEAR,
+            .mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_NEAREST,
+            .address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+            .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+            .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+        };
         return {
-            .nearest_clamped = SDL_CreateGPUSampler(device, &nearestClampedSamplerCreateInfo)
+            .nearest_clamped = SDL_CreateGPUSampler(device, &nearestClampedSamplerCreateInfo),
+            .linear_clamped = SDL_CreateGPUSampler(device, &linearClampedSamplerCreateInfo),
         };
     }
 
+    float ElapsedMilliseconds(const Uint64 start, const Uint64 end) {
+        return static_cast<float>(end - start) * 1000.0f / static_cast<float>(SDL_GetPerformanceFrequency());
+    }
+
+    void ReleaseOldestFence() {
+        SDL_ReleaseGPUFence(device, frameTiming.fences[frameTiming.fenceHead]);
+        frameTiming.fences[frameTiming.fenceHead] = nullptr;
+        frameTiming.fenceHead = (frameTiming.fenceHead + 1) % MaxFramesInFlight;
+        frameTiming.fenceCount--;
+    }
+
+    void ReleaseRenderTargets() {
+        if (renderTargets.color != nullptr) {
+            SDL_ReleaseGPUTexture(device, renderTargets.color);
+        }
+        if (renderTargets.depth != nullptr) {
+            SDL_ReleaseGPUTexture(device, renderTargets.depth);
+        }
+        renderTargets.color = nullptr;
+        renderTargets.depth = nullptr;
+    }
+
+    void CreateRenderTargets(const Uint32 width, const Uint32 height) {
+        ReleaseRenderTargets();
+
+        SDL_GPUTextureCreateInfo colorTextureCreateInfo = {
+            .type = SDL_GPU_TEXTURETYPE_2D,
+            .format = renderTargets.colorFormat,
+            .usage = SDL_GPU_TEXTUREUSAGE_SAMPLER | SDL_GPU_TEXTUREUSAGE_COLOR_TARGET,
+            .width = width,
+            .height = height,
+            .layer_count_or_depth = 1,
+            .num_levels = 1,
+            .sample_count = SDL_GPU_SAMPLECOUNT_1,
+        };
+        renderTargets.color = SDL_CreateGPUTexture(device, &colorTextureCreateInfo);
+        SDL_SetGPUTextureName(device, renderTargets.color, "Scene Color Target");
+
+        SDL_GPUTextureCreateInfo depthTextureCreateInfo = {
+            .type = SDL_GPU_TEXTURETYPE_2D,
+            .format = SDL_GPU_TEXTUREFORMAT_D16_UNORM,
+            .usage = SDL_GPU_TEXTUREUSAGE_SAMPLER | SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET,
+            .width = width,
+            .height = height,
+            .layer_count_or_depth = 1,
+            .num_levels = 1,
+            .sample_count = SDL_GPU_SAMPLECOUNT_1,
+        };
+        renderTargets.depth = SDL_CreateGPUTexture(device, &depthTextureCreateInfo);
+        SDL_SetGPUTextureName(device, renderTargets.depth, "Scene Depth Target");
+
+        renderTargets.width = width;
+        renderTargets.height = height;
+    }
+
     void InitRenderer() {
         if (!SDL_InitSubSystem(SDL_INIT_VIDEO)) {
           SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Could not init sdl video: %s\n", SDL_GetError());
@@ -242,24 +427,19 @@ namespace rendering {
 
         pipelines = {
             .sprite = LoadSpritePipeline(device, textureFormat),
+            .upscale = LoadUpscalePipeline(device, textureFormat),
+            .clear_color_depth = LoadClearPipeline(device, textureFormat, true),
+            .clear_depth = LoadClearPipeline(device, textureFormat, false),
         };
 
-        SDL_GPUTextureCreateInfo depthTextureCreateInfo = {
-            .type = SDL_GPU_TEXTURETYPE_2D,
-            .format = SDL_GPU_TEXTUREFORMAT_D16_UNORM,
-            .usage = SDL_GPU_TEXTUREUSAGE_SAMPLER | SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET,
-            .width = WindowWidth,
-            .height = WindowHeight,
-            .layer_count_or_depth = 1,
-            .num_levels = 1,
-            .sample_count = SDL_GPU_SAMPLECOUNT_1,
-        };
-        depthTexture = SDL_CreateGPUTexture(device, &depthTextureCreateInfo);
-        projectionMatrix = glm::perspectiveFovLH<float>(Fov, WindowWidth, WindowHeight, 0.01f, 1000.0f);
+        int windowWidth, windowHeight;
+        SDL_GetWindowSizeInPixels(window, &windowWidth, &windowHeight);
+        renderTargets.colorFormat = textureFormat;
+        CreateRenderTargets(static_cast<Uint32>(windowWidth), static_cast<Uint32>(windowHeight));
 
         SDL_GPUTransferBufferCreateInfo spriteDataTransferBufferCreateInfo = {
             .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
-            .size = sprite::MaxSpriteCount * sizeof(sprite::Instance),
+            .size = sprite::MaxSpriteCount * sizeof(sprite::Instance) + sprite::MaxIndexCount * sizeof(Uint32),
         };
 
         sprite::dataTransferBuffer = SDL_CreateGPUTransferBuffer(device, &spriteDataTransferBufferCreateInfo);
@@ -272,21 +452,47 @@ namespace rendering {
 
         sprite::dataBuffer = SDL_CreateGPUBuffer(device, &spriteDataBufferCreateInfo);
         SDL_SetGPUBufferName(device, sprite::dataBuffer, "Sprite Data Buffer");
+
+        SDL_GPUBufferCreateInfo spriteIndexBufferCreateInfo = {
+            .usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ,
+            .size = sprite::MaxIndexCount * sizeof(Uint32)
+        };
+
+        sprite::indexBuffer = SDL_CreateGPUBuffer(device, &spriteIndexBufferCreateInfo);
+        SDL_SetGPUBufferName(device, sprite::indexBuffer, "Sprite Index Buffer");
         SDL_GPUSwapchainComposition swapchainComposition = SDL_GPU_SWAPCHAINCOMPOSITION_SDR;
-        SDL_SetGPUSwapchainParameters(device, window, swapchainComposition, SDL_GPU_PRESENTMODE_IMMEDIATE);
+        // Note: Prefer not waiting on vsync so frame timings reflect the work, swapchain acquisition is timed for when we can't
+        SDL_GPUPresentMode presentMode = SDL_GPU_PRESENTMODE_VSYNC;
+        if (SDL_WindowSupportsGPUPresentMode(device, window, SDL_GPU_PRESENTMODE_IMMEDIATE)) {
+            presentMode = SDL_GPU_PRESENTMODE_IMMEDIATE;
+        } else if (SDL_WindowSupportsGPUPresentMode(device, window, SDL_GPU_PRESENTMODE_MAILBOX)) {
+            presentMode = SDL_GPU_PRESENTMODE_MAILBOX;
+        }
+        if (!SDL_SetGPUSwapchainParameters(device, window, swapchainComposition, presentMode)) {
+          SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Could not set swapchain parameters: %s\n", SDL_GetError());
+        }
+        SDL_SetGPUAllowedFramesInFlight(device, MaxFramesInFlight);
     }
 
     void ReleaseResources() {
         for (const auto& texture : textures) {
             SDL_ReleaseGPUTexture(device, texture);
         }
-        SDL_ReleaseGPUTexture(device, depthTexture);
+        ReleaseRenderTargets();
+        while (frameTiming.fenceCount > 0) {
+            ReleaseOldestFence();
+        }
 
         SDL_ReleaseGPUTransferBuffer(device, sprite::dataTransferBuffer);
         SDL_ReleaseGPUBuffer(device, sprite::dataBuffer);
+        SDL_ReleaseGPUBuffer(device, sprite::indexBuffer);
 
         SDL_ReleaseGPUGraphicsPipeline(device, pipelines.sprite);
+        SDL_ReleaseGPUGraphicsPipeline(device, pipelines.upscale);
+        SDL_ReleaseGPUGraphicsPipeline(device, pipelines.clear_color_depth);
+        SDL_ReleaseGPUGraphicsPipeline(device, pipelines.clear_depth);
         SDL_ReleaseGPUSampler(device, samplers.nearest_clamped);
+        SDL_ReleaseGPUSampler(device, samplers.linear_clamped);
         SDL_DestroyGPUDevice(device);
         SDL_DestroyWindow(window);
         SDL_QuitSubSystem(SDL_INIT_VIDEO);
@@ -368,10 +574,15 @@ namespace rendering {
     }
 
     void BeginFrame() {
+        frameTiming.frameStart = SDL_GetPerformanceCounter();
         sprite::drawCount = 0;
     }
 
     void DrawSprite(const Sprite &sprite, const transform::Transform &transform) {
+        if (sprite::drawCount >= sprite::MaxSpriteCount) {
+            return;
+        }
+
         sprite::drawQueue[sprite::drawCount] = {
             .element = sprite,
             .transform = transform,
@@ -379,7 +590,21 @@ namespace rendering {
         sprite::drawCount += 1;
     }
 
-    void UploadSpriteData(SDL_GPUCommandBuffer *commandBuffer) {
+    float BoundingRadius(const Sprite &sprite) {
+        // Note: The sprite quad spans -scale..scale, so the bounding radius is the half diagonal
+        return SDL_sqrtf(sprite.scale_x * sprite.scale_x + sprite.scale_y * sprite.scale_y);
+    }
+
+    glm::mat4 ViewProjection(const View &view) {
+        // Note: Aspect comes from the full size target, the resolution scale is uniform so it doesn't change it
+        const float width = view.viewport.width * renderTargets.width;
+        const float height = view.viewport.height * renderTargets.height;
+        const glm::mat4 projectionMatrix = glm::perspectiveFovLH<float>(glm::radians(view.fov), width, height, view.near_plane, view.far_plane);
+
+        return projectionMatrix * view.camera.View();
+    }
+
+    void UploadSpriteData(SDL_GPUCommandBuffer *commandBuffer, const View *views, sprite::ViewDraw *viewDraws, const Uint32 viewCount) {
         sprite::Instance *data = (sprite::Instance *) SDL_MapGPUTransferBuffer(device, sprite::dataTransferBuffer, true);
         if (data == nullptr) {
             SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Could not acquire sprite vertex buffer: %s\n", SDL_GetError());
@@ -404,6 +629,26 @@ namespace rendering {
             data[i].a = 1.0f;
         }
 
+        // Indices live after the full instance region so their offset doesn't move with drawCount
+        Uint32 *indices = (Uint32 *) (data + sprite::MaxSpriteCount);
+        Uint32 indexCount = 0;
+
+        for (Uint32 view = 0; view < viewCount; view++) {
+            viewDraws[view].viewProjection = ViewProjection(views[view]);
+            viewDraws[view].firstIndex = indexCount;
+
+            const spatial::Frustum frustum = spatial::Frustum::FromViewProjection(viewDraws[view].viewProjection);
+            for (Uint32 i = 0; i < sprite::drawCount; i++) {
+                const QueuedDraw<Sprite> &queuedDraw = sprite::drawQueue[i];
+                if (frustum.ContainsSphere(queuedDraw.transform.position, BoundingRadius(queuedDraw.element))) {
+                    indices[indexCount] = i;
+                    indexCount++;
+                }
+            }
+
+            viewDraws[view].indexCount = indexCount - viewDraws[view].firstIndex;
+        }
+
         SDL_UnmapGPUTransferBuffer(device, sprite::dataTransferBuffer);
 
         SDL_GPUCopyPass *copyPass = SDL_BeginGPUCopyPass(commandBuffer);
@@ -419,15 +664,47 @@ namespace rendering {
             .size = static_cast<Uint32>(sprite::drawCount * sizeof(sprite::Instance))
         };
 
-        SDL_UploadToGPUBuffer(copyPass, &source, &destination, true);
+        // Note: Zero sized copies are invalid on some backends, an empty region or a fully culled view is normal
+        if (sprite::drawCount > 0) {
+            SDL_UploadToGPUBuffer(copyPass, &source, &destination, true);
+        }
+
+        SDL_GPUTransferBufferLocation indexSource = {
+            .transfer_buffer = sprite::dataTransferBuffer,
+            .offset = static_cast<Uint32>(sprite::MaxSpriteCount * sizeof(sprite::Instance))
+        };
+
+        SDL_GPUBufferRegion indexDestination = {
+            .buffer = sprite::indexBuffer,
+            .offset = 0,
+            .size = static_cast<Uint32>(indexCount * sizeof(Uint32))
+        };
+
+        if (indexCount > 0) {
+            SDL_UploadToGPUBuffer(copyPass, &indexSource, &indexDestination, true);
+        }
 
         SDL_EndGPUCopyPass(copyPass);
     }
 
-    void DrawSprites(SDL_GPUCommandBuffer *commandBuffer, SDL_GPUTexture *swapchainTexture, const glm::mat4 &viewMatrix) {
+    bool IsValidView(const View &view) {
+        // Note: Written so NaN fails every check
+        const bool validViewport = view.viewport.width > 0.0f && view.viewport.height > 0.0f;
+        const bool validFov = view.fov > 0.0f && view.fov < 180.0f;
+        const bool validDepthRange = view.near_plane > 0.0f && view.far_plane > view.near_plane && std::isfinite(view.far_plane);
+        return validViewport && validFov && validDepthRange;
+    }
 
+    bool ViewportsOverlap(const Viewport &a, const Viewport &b) {
+        return a.x < b.x + b.width && b.x < a.x + a.width &&
+               a.y < b.y + b.height && b.y < a.y + a.height;
+    }
+
+    void DrawSprites(SDL_GPUCommandBuffer *commandBuffer, const Uint32 renderWidth, const Uint32 renderHeight,
+                     const View *views, const sprite::ViewDraw *viewDraws, const Uint32 viewCount) {
+        // Note: One pass for every view, the load ops clear the whole target once and overlapping views reset their own region
         SDL_GPUColorTargetInfo colorTargetInfo = {
-            .texture = swapchainTexture,
+            .texture = renderTargets.color,
             .mip_level = 0,
             .clear_color = CLEAR_COLOR,
             .load_op = SDL_GPU_LOADOP_CLEAR,
@@ -436,7 +713,7 @@ namespace rendering {
         };
 
         SDL_GPUDepthStencilTargetInfo depthStencilTargetInfo = {
-            .texture = depthTexture,
+            .texture = renderTargets.depth,
             .clear_depth = 1,
             .load_op = SDL_GPU_LOADOP_CLEAR,
             .store_op = SDL_GPU_STOREOP_STORE,
@@ -451,49 +728,239 @@ namespace rendering {
             SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Could not begin render pass: %s\n",SDL_GetError());
             return;
         }
-        glm::mat4 viewProjectionMatrix = projectionMatrix * viewMatrix;
 
-        SDL_BindGPUGraphicsPipeline(renderPass, pipelines.sprite);
-        SDL_BindGPUVertexStorageBuffers(renderPass, 0, &sprite::dataBuffer, 1);
+        SDL_GPUBuffer *storageBuffers[] = {sprite::dataBuffer, sprite::indexBuffer};
 
         SDL_GPUTextureSamplerBinding textureSamplerBinding = {
             // TODO (Michael): I'm not sure how best to get this information, may just leave this as is until I can implement a sprite atlas
             .texture = textures.at(0),
             .sampler = samplers.nearest_clamped,
         };
-        SDL_BindGPUFragmentSamplers(renderPass, 0, &textureSamplerBinding, 1);
-        SDL_PushGPUVertexUniformData(commandBuffer, 0, &viewProjectionMatrix, sizeof(glm::mat4));
 
-        SDL_DrawGPUPrimitives(renderPass, sprite::drawCount * 6, 1, 0, 0);
+        for (Uint32 view = 0; view < viewCount; view++) {
+            const Viewport &normalizedViewport = views[view].viewport;
+            SDL_GPUViewport viewport = {
+                .x = normalizedViewport.x * renderWidth,
+                .y = normalizedViewport.y * renderHeight,
+                .w = normalizedViewport.width * renderWidth,
+                .h = normalizedViewport.height * renderHeight,
+                .min_depth = 0.0f,
+                .max_depth = 1.0f,
+            };
+            SDL_SetGPUViewport(renderPass, &viewport);
+
+            // Views are layered in order, only a view drawn over an earlier one has anything to reset
+            bool overlapsEarlierView = false;
+            for (Uint32 earlier = 0; earlier < view; earlier++) {
+                overlapsEarlierView = overlapsEarlierView || ViewportsOverlap(normalizedViewport, views[earlier].viewport);
+            }
+
+            if (overlapsEarlierView) {
+                const bool clearBackground = views[view].clear_background;
+                SDL_BindGPUGraphicsPipeline(renderPass, clearBackground ? pipelines.clear_color_depth : pipelines.clear_depth);
+                SDL_PushGPUFragmentUniformData(commandBuffer, 0, &CLEAR_COLOR, sizeof(SDL_FColor));
+                SDL_DrawGPUPrimitives(renderPass, 3, 1, 0, 0);
+            }
+
+            if (viewDraws[view].indexCount == 0) {
+                continue;
+            }
+
+            SDL_BindGPUGraphicsPipeline(renderPass, pipelines.sprite);
+            SDL_BindGPUVertexStorageBuffers(renderPass, 0, storageBuffers, 2);
+            SDL_BindGPUFragmentSamplers(renderPass, 0, &textureSamplerBinding, 1);
+
+            const sprite::ViewUniforms uniforms = {
+                .viewProjection = viewDraws[view].viewProjection,
+                .firstIndex = viewDraws[view].firstIndex,
+            };
+            SDL_PushGPUVertexUniformData(commandBuffer, 0, &uniforms, sizeof(sprite::ViewUniforms));
+
+            SDL_DrawGPUPrimitives(renderPass, viewDraws[view].indexCount * 6, 1, 0, 0);
+        }
+
         SDL_EndGPURenderPass(renderPass);
+    }
 
+    void UpscaleToSwapchain(SDL_GPUCommandBuffer *commandBuffer, SDL_GPUTexture *swapchainTexture, const Uint32 renderWidth, const Uint32 renderHeight) {
+        SDL_GPUColorTargetInfo colorTargetInfo = {
+            .texture = swapchainTexture,
+            .mip_level = 0,
+            .load_op = SDL_GPU_LOADOP_DONT_CARE,
+            .store_op = SDL_GPU_STOREOP_STORE,
+            .cycle = false,
+        };
+
+        SDL_GPURenderPass *renderPass = SDL_BeginGPURenderPass(commandBuffer, &colorTargetInfo, 1, nullptr);
+        if (renderPass == nullptr) {
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Could not begin upscale pass: %s\n", SDL_GetError());
+            return;
+        }
+
+        // The source rect is inset by half a texel, a plain blit would filter in the cleared texels past the region
+        const float texelWidth = 1.0f / renderTargets.width;
+        const float texelHeight = 1.0f / renderTargets.height;
+        const UpscaleUniforms uniforms = {
+            .uv_scale = {renderWidth * texelWidth, renderHeight * texelHeight},
+            .uv_min = {0.5f * texelWidth, 0.5f * texelHeight},
+            .uv_max = {(renderWidth - 0.5f) * texelWidth, (renderHeight - 0.5f) * texelHeight},
+        };
+
+        SDL_GPUTextureSamplerBinding textureSamplerBinding = {
+            .texture = renderTargets.color,
+            .sampler = samplers.linear_clamped,
+        };
+
+        SDL_BindGPUGraphicsPipeline(renderPass, pipelines.upscale);
+        SDL_BindGPUFragmentSamplers(renderPass, 0, &textureSamplerBinding, 1);
+        SDL_PushGPUFragmentUniformData(commandBuffer, 0, &uniforms, sizeof(UpscaleUniforms));
+
+        SDL_DrawGPUPrimitives(renderPass, 3, 1, 0, 0);
+        SDL_EndGPURenderPass(renderPass);
     }
 
-    void DrawFrame(const camera::Camera& camera) {
-        SDL_GPUCommandBuffer *uploadCommandBuffer = SDL_AcquireGPUCommandBuffer(device);
-        if (uploadCommandBuffer == nullptr) {
-          SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Could not acquire upload command buffer: %s\n", SDL_GetError());
-          return;
+    /**
+     * Releases finished frames and only blocks once every in flight slot is taken.
+     *
+     * Note: SDL_GPU has no timestamp queries. Gpu time is only known when the cpu had to wait, it is then the
+     * gap between consecutive waited on completions, which is the rate the gpu retires frames at.
+     */
+    resolution::FrameTimings RetireFrames() {
+        resolution::FrameTimings timings = {
+            .cpu_time = frameTiming.cpuTime,
+            .gpu_time = 0.0f,
+            .gpu_bound = false,
+        };
+
+        // Frames that already finished only tell us the gpu kept up, not when they finished
+        while (frameTiming.fenceCount > 0 && SDL_QueryGPUFence(device, frameTiming.fences[frameTiming.fenceHead])) {
+            ReleaseOldestFence();
+            frameTiming.lastCompletion = 0;
+        }
+
+        if (frameTiming.fenceCount < MaxFramesInFlight) {
+            return timings;
+        }
+
+        const Uint64 waitStart = SDL_GetPerformanceCounter();
+        SDL_WaitForGPUFences(device, true, &frameTiming.fences[frameTiming.fenceHead], 1);
+        const Uint64 waitEnd = SDL_GetPerformanceCounter();
+        ReleaseOldestFence();
+
+        timings.gpu_bound = true;
+        if (frameTiming.lastCompletion != 0) {
+            timings.gpu_time = ElapsedMilliseconds(frameTiming.lastCompletion, waitEnd);
+        } else {
+            // First wait in a row, the whole frame period is the best estimate of the gpu's pace
+            timings.gpu_time = frameTiming.cpuTime + ElapsedMilliseconds(waitStart, waitEnd);
         }
+        frameTiming.lastCompletion = waitEnd;
 
-        UploadSpriteData(uploadCommandBuffer);
-        SDL_SubmitGPUCommandBuffer(uploadCommandBuffer);
+        // Time spent blocked on the gpu is not cpu work for this frame
+        frameTiming.frameStart += waitEnd - waitStart;
 
-        SDL_GPUCommandBuffer *renderCommandBuffer = SDL_AcquireGPUCommandBuffer(device);
-        if (uploadCommandBuffer == nullptr) {
+        return timings;
+    }
+
+    void DrawViews(const View *views, const Uint32 requestedViewCount) {
+        resolution::FrameTimings timings = RetireFrames();
+
+        SDL_GPUCommandBuffer *commandBuffer = SDL_AcquireGPUCommandBuffer(device);
+        if (commandBuffer == nullptr) {
           SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Could not acquire render command buffer: %s\n", SDL_GetError());
           return;
         }
 
         SDL_GPUTexture *swapchainTexture;
-        if (!SDL_WaitAndAcquireGPUSwapchainTexture(renderCommandBuffer, window, &swapchainTexture, nullptr, nullptr)) {
+        Uint32 swapchainWidth, swapchainHeight;
+        const Uint64 acquireStart = SDL_GetPerformanceCounter();
+        if (!SDL_WaitAndAcquireGPUSwapchainTexture(commandBuffer, window, &swapchainTexture, &swapchainWidth, &swapchainHeight)) {
           SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Could not acquire swapchain texture: %s\n", SDL_GetError());
+          SDL_CancelGPUCommandBuffer(commandBuffer);
+          return;
+        }
+        const Uint64 acquireEnd = SDL_GetPerformanceCounter();
+
+        // Blocking on presentation is the gpu side holding the frame back, not cpu work
+        frameTiming.frameStart += acquireEnd - acquireStart;
+        const float acquireTime = ElapsedMilliseconds(acquireStart, acquireEnd);
+        if (acquireTime > AcquireWaitThreshold) {
+            if (!timings.gpu_bound) {
+                timings.gpu_time = frameTiming.cpuTime;
+            }
+            timings.gpu_bound = true;
+            timings.gpu_time += acquireTime;
+        }
+        const float scale = resolutionScaler.Update(timings);
+
+        // Note: The swapchain texture is null while the window is minimized
+        if (swapchainTexture == nullptr) {
+          SDL_SubmitGPUCommandBuffer(commandBuffer);
           return;
         }
 
-        glm::mat4 viewMatrix = camera.View();
-        DrawSprites(renderCommandBuffer, swapchainTexture, viewMatrix);
+        // Targets have to match the swapchain before view projections are built from their size
+        if (swapchainWidth != renderTargets.width || swapchainHeight != renderTargets.height) {
+            CreateRenderTargets(swapchainWidth, swapchainHeight);
+        }
+
+        // Invalid views would build a singular projection and a NaN frustum, so they are dropped before culling
+        View drawnViews[sprite::MaxViewCount];
+        Uint32 viewCount = 0;
+        for (Uint32 view = 0; view < requestedViewCount; view++) {
+            if (!IsValidView(views[view])) {
+                SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Dropping view %u, its viewport or projection is invalid\n", view);
+                continue;
+            }
+            if (viewCount == sprite::MaxViewCount) {
+                SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Dropping view %u, only %u views can be drawn per frame\n",
+                             view, sprite::MaxViewCount);
+                continue;
+            }
+            drawnViews[viewCount] = views[view];
+            viewCount++;
+        }
+
+        // Note: Zeroed so a failed upload draws nothing instead of reading garbage index ranges
+        sprite::ViewDraw viewDraws[sprite::MaxViewCount] = {};
+        UploadSpriteData(commandBuffer, drawnViews, viewDraws, viewCount);
+
+        const Uint32 renderWidth = SDL_max(1u, static_cast<Uint32>(std::lround(renderTargets.width * scale)));
+        const Uint32 renderHeight = SDL_max(1u, static_cast<Uint32>(std::lround(renderTargets.height * scale)));
+
+        DrawSprites(commandBuffer, renderWidth, renderHeight, drawnViews, viewDraws, viewCount);
+        UpscaleToSwapchain(commandBuffer, swapchainTexture, renderWidth, renderHeight);
+
+        frameTiming.cpuTime = ElapsedMilliseconds(frameTiming.frameStart, SDL_GetPerformanceCounter());
+        SDL_GPUFence *fence = SDL_SubmitGPUCommandBufferAndAcquireFence(commandBuffer);
+        if (fence != nullptr) {
+            frameTiming.fences[(frameTiming.fenceHead + frameTiming.fenceCount) % MaxFramesInFlight] = fence;
+            frameTiming.fenceCount++;
+        }
+    }
+
+    void DrawFrame(const std::vector<View> &views) {
+        DrawViews(views.data(), static_cast<Uint32>(views.size()));
+    }
+
+    void DrawFrame(const camera::Camera& camera) {
+        const View view = {.camera = camera};
+        DrawViews(&view, 1);
+    }
+
+    void SetTargetFrameTime(const float milliseconds) {
+        resolutionScaler.SetTargetFrameTime(milliseconds);
+    }
+
+    void SetResolutionScaling(const resolution::ScalerSettings &settings) {
+        resolutionScaler.SetSettings(settings);
+    }
+
+    float GetResolutionScale() {
+        return resolutionScaler.Scale();
+    }
 
-        SDL_SubmitGPUCommandBuffer(renderCommandBuffer);
+    glm::mat4 ViewProjection(const camera::Camera &camera) {
+        return ViewProjection(View{.camera = camera});
     }
 }
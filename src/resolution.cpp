@@ -0,0 +1,67 @@
+#include "resolution.h"
+#include <algorithm>
+#include <cmath>
+
+namespace resolution {
+    DynamicScaler::DynamicScaler() : DynamicScaler(ScalerSettings{}) {
+    }
+
+    DynamicScaler::DynamicScaler(const ScalerSettings &settings) {
+        this->settings = settings;
+        this->scale = settings.max_scale;
+        this->smoothedCpuTime = 0.0f;
+        this->smoothedGpuTime = 0.0f;
+        this->smoothedGpuBound = 0.0f;
+        this->cooldown = 0;
+    }
+
+    float DynamicScaler::Update(const FrameTimings &timings) {
+        const float smoothing = this->settings.smoothing;
+        this->smoothedCpuTime += (timings.cpu_time - this->smoothedCpuTime) * smoothing;
+        this->smoothedGpuBound += ((timings.gpu_bound ? 1.0f : 0.0f) - this->smoothedGpuBound) * smoothing;
+        if (timings.gpu_bound) {
+            this->smoothedGpuTime += (timings.gpu_time - this->smoothedGpuTime) * smoothing;
+        }
+
+        if (this->cooldown > 0) {
+            this->cooldown--;
+            return this->scale;
+        }
+
+        // Dropping resolution only helps when the gpu is what is holding the frame back
+        const bool gpuBound = this->smoothedGpuBound > 0.5f;
+        const float frameTime = gpuBound ? std::max(this->smoothedCpuTime, this->smoothedGpuTime) : this->smoothedCpuTime;
+        const float target = this->settings.target_frame_time;
+
+        if (frameTime > target * this->settings.decrease_threshold) {
+            if (!gpuBound || this->smoothedGpuTime < this->smoothedCpuTime) {
+                return this->scale;
+            }
+
+            // Pixel cost goes with the square of the scale, so step straight to the estimate
+            const float estimate = this->scale * std::sqrt(target / this->smoothedGpuTime);
+            this->scale = std::clamp(estimate, this->settings.min_scale, this->settings.max_scale);
+            this->cooldown = this->settings.cooldown_frames;
+        } else if (frameTime < target * this->settings.increase_threshold && this->scale < this->settings.max_scale) {
+            // Creep back up so a single quiet frame doesn't cause oscillation
+            this->scale = std::min(this->scale + this->settings.increase_step, this->settings.max_scale);
+            this->cooldown = this->settings.cooldown_frames;
+        }
+
+        return this->scale;
+    }
+
+    float DynamicScaler::Scale() const {
+        return this->scale;
+    }
+
+    void DynamicScaler::SetTargetFrameTime(const float milliseconds) {
+        this->settings.target_frame_time = milliseconds;
+    }
+
+    void DynamicScaler::SetSettings(const ScalerSettings &settings) {
+        this->settings = settings;
+        this->scale = std::clamp(this->scale, settings.min_scale, settings.max_scale);
+        this->cooldown = 0;
+    }
+}
@@ -0,0 +1,231 @@
+#include "spatial.h"
+#include "glm/common.hpp"
+#include "glm/geometric.hpp"
+#include "glm/matrix.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <initializer_list>
+
+namespace spatial {
+    Frustum Frustum::FromViewProjection(const glm::mat4 &viewProjection) {
+        // glm is column major, so rows have to be gathered by hand
+        const glm::vec4 row0 = glm::vec4(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+        const glm::vec4 row1 = glm::vec4(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+        const glm::vec4 row2 = glm::vec4(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+        const glm::vec4 row3 = glm::vec4(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+        Frustum frustum;
+        frustum.planes[Left] = row3 + row0;
+        frustum.planes[Right] = row3 - row0;
+        frustum.planes[Bottom] = row3 + row1;
+        frustum.planes[Top] = row3 - row1;
+        frustum.planes[Near] = row2;
+        frustum.planes[Far] = row3 - row2;
+
+        for (glm::vec4 &plane : frustum.planes) {
+            plane /= glm::length(glm::vec3(plane));
+        }
+
+        const glm::mat4 inverse = glm::inverse(viewProjection);
+        int corner = 0;
+        for (float z : {0.0f, 1.0f}) {
+            for (float y : {-1.0f, 1.0f}) {
+                for (float x : {-1.0f, 1.0f}) {
+                    const glm::vec4 world = inverse * glm::vec4(x, y, z, 1.0f);
+                    frustum.corners[corner] = glm::vec3(world) / world.w;
+                    corner++;
+                }
+            }
+        }
+
+        return frustum;
+    }
+
+    bool Frustum::ContainsSphere(const glm::vec3 &center, const float radius) const {
+        for (const glm::vec4 &plane : this->planes) {
+            if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool Frustum::IntersectsBox(const glm::vec3 &min, const glm::vec3 &max) const {
+        for (const glm::vec4 &plane : this->planes) {
+            // Only the corner furthest along the plane normal needs checking
+            const glm::vec3 positive = glm::vec3(
+                plane.x >= 0.0f ? max.x : min.x,
+                plane.y >= 0.0f ? max.y : min.y,
+                plane.z >= 0.0f ? max.z : min.z
+            );
+            if (glm::dot(glm::vec3(plane), positive) + plane.w < 0.0f) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    SpatialGrid::SpatialGrid(const float cellSize) {
+        assert(cellSize > 0.0f);
+        this->cellSize = cellSize;
+        this->inverseCellSize = 1.0f / cellSize;
+        this->maxRadius = 0.0f;
+        this->minZ = std::numeric_limits<float>::max();
+        this->maxZ = std::numeric_limits<float>::lowest();
+    }
+
+    ObjectHandle SpatialGrid::Insert(const glm::vec3 &position, const float radius) {
+        ObjectHandle handle;
+        if (!this->freeHandles.empty()) {
+            handle = this->freeHandles.back();
+            this->freeHandles.pop_back();
+        } else {
+            handle = static_cast<ObjectHandle>(this->objects.size());
+            this->objects.push_back({});
+        }
+
+        Object &object = this->objects[handle];
+        object.position = position;
+        object.radius = radius;
+
+        this->maxRadius = std::max(this->maxRadius, radius);
+        this->minZ = std::min(this->minZ, position.z);
+        this->maxZ = std::max(this->maxZ, position.z);
+
+        AddToCell(handle, KeyFor(position));
+        return handle;
+    }
+
+    void SpatialGrid::Move(const ObjectHandle handle, const glm::vec3 &position) {
+        Object &object = this->objects[handle];
+        assert(object.slot != InvalidObject);
+
+        object.position = position;
+        this->minZ = std::min(this->minZ, position.z);
+        this->maxZ = std::max(this->maxZ, position.z);
+
+        const CellKey key = KeyFor(position);
+        if (key == object.cell) {
+            return;
+        }
+
+        RemoveFromCell(handle);
+        AddToCell(handle, key);
+    }
+
+    void SpatialGrid::Remove(const ObjectHandle handle) {
+        assert(this->objects[handle].slot != InvalidObject);
+
+        RemoveFromCell(handle);
+        this->objects[handle].slot = InvalidObject;
+        this->freeHandles.push_back(handle);
+    }
+
+    const glm::vec3 &SpatialGrid::GetPosition(const ObjectHandle handle) const {
+        return this->objects[handle].position;
+    }
+
+    std::size_t SpatialGrid::Size() const {
+        return this->objects.size() - this->freeHandles.size();
+    }
+
+    void SpatialGrid::QueryRect(const glm::vec2 &min, const glm::vec2 &max, std::vector<ObjectHandle> &results) const {
+        const std::int32_t startX = CellCoordinate(min.x - this->maxRadius);
+        const std::int32_t startY = CellCoordinate(min.y - this->maxRadius);
+        const std::int32_t endX = CellCoordinate(max.x + this->maxRadius);
+        const std::int32_t endY = CellCoordinate(max.y + this->maxRadius);
+
+        VisitCells(startX, startY, endX, endY, [&](const std::int32_t, const std::int32_t, const Cell &cell) {
+            for (const ObjectHandle handle : cell.handles) {
+                const Object &object = this->objects[handle];
+                if (object.position.x + object.radius >= min.x && object.position.x - object.radius <= max.x &&
+                    object.position.y + object.radius >= min.y && object.position.y - object.radius <= max.y) {
+                    results.push_back(handle);
+                }
+            }
+        });
+    }
+
+    void SpatialGrid::QueryFrustum(const Frustum &frustum, std::vector<ObjectHandle> &results) const {
+        glm::vec2 min = glm::vec2(frustum.corners[0]);
+        glm::vec2 max = glm::vec2(frustum.corners[0]);
+        for (const glm::vec3 &corner : frustum.corners) {
+            min = glm::min(min, glm::vec2(corner));
+            max = glm::max(max, glm::vec2(corner));
+        }
+
+        const std::int32_t startX = CellCoordinate(min.x - this->maxRadius);
+        const std::int32_t startY = CellCoordinate(min.y - this->maxRadius);
+        const std::int32_t endX = CellCoordinate(max.x + this->maxRadius);
+        const std::int32_t endY = CellCoordinate(max.y + this->maxRadius);
+
+        VisitCells(startX, startY, endX, endY, [&](const std::int32_t x, const std::int32_t y, const Cell &cell) {
+            // Cells are loose by the largest radius so objects hanging over the edge are still found
+            const glm::vec3 cellMin = glm::vec3(
+                x * this->cellSize - this->maxRadius,
+                y * this->cellSize - this->maxRadius,
+                this->minZ - this->maxRadius
+            );
+            const glm::vec3 cellMax = glm::vec3(
+                (x + 1) * this->cellSize + this->maxRadius,
+                (y + 1) * this->cellSize + this->maxRadius,
+                this->maxZ + this->maxRadius
+            );
+            if (!frustum.IntersectsBox(cellMin, cellMax)) {
+                return;
+            }
+
+            for (const ObjectHandle handle : cell.handles) {
+                const Object &object = this->objects[handle];
+                if (frustum.ContainsSphere(object.position, object.radius)) {
+                    results.push_back(handle);
+                }
+            }
+        });
+    }
+
+    std::int32_t SpatialGrid::CellCoordinate(const float value) const {
+        const float cell = std::floor(value * this->inverseCellSize);
+        const float lowest = static_cast<float>(std::numeric_limits<std::int32_t>::min());
+        const float highest = static_cast<float>(std::numeric_limits<std::int32_t>::max() - 128);
+        return static_cast<std::int32_t>(std::clamp(cell, lowest, highest));
+    }
+
+    SpatialGrid::CellKey SpatialGrid::KeyFor(const std::int32_t x, const std::int32_t y) const {
+        return (static_cast<CellKey>(static_cast<std::uint32_t>(x)) << 32) | static_cast<std::uint32_t>(y);
+    }
+
+    SpatialGrid::CellKey SpatialGrid::KeyFor(const glm::vec3 &position) const {
+        return KeyFor(CellCoordinate(position.x), CellCoordinate(position.y));
+    }
+
+    void SpatialGrid::AddToCell(const ObjectHandle handle, const CellKey key) {
+        Cell &cell = this->cells[key];
+
+        Object &object = this->objects[handle];
+        object.cell = key;
+        object.slot = static_cast<std::uint32_t>(cell.handles.size());
+        cell.handles.push_back(handle);
+    }
+
+    void SpatialGrid::RemoveFromCell(const ObjectHandle handle) {
+        const Object &object = this->objects[handle];
+        const auto found = this->cells.find(object.cell);
+        assert(found != this->cells.end());
+        std::vector<ObjectHandle> &handles = found->second.handles;
+
+        // Swap remove, patching the slot of whichever handle got moved into the hole
+        const ObjectHandle last = handles.back();
+        handles[object.slot] = last;
+        this->objects[last].slot = object.slot;
+        handles.pop_back();
+
+        if (!handles.empty()) {
+            return;
+        }
+
+        // Drop empty cells so long running sessions with movers don't keep every cell ever visited
+        this->cells.erase(found);
+    }
+}